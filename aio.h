@@ -0,0 +1,206 @@
+#ifndef AIO_H
+#define AIO_H
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <vector>
+#include <sys/uio.h>
+#include "db.h"
+#include "page.h"
+
+// asynchronous I/O backends
+enum IOBackend { AIO_AUTO, AIO_URING, AIO_THREADS, AIO_SYNC };
+
+// default number of requests in flight at once
+const int AIODEPTH = 64;
+
+// most worker threads of the thread pool backend
+const int AIOTHREADS = 8;
+
+// a run of consecutive pages, starting at pageNo, to be read or
+// written.  The pages may lie anywhere in memory.  status and done
+// are filled in by the backend when the request completes.
+struct IORequest
+{
+  File*		file;
+  int		pageNo;
+  struct iovec*	iov;	// page buffers in memory, in page order
+  int		count;	// number of pages
+  bool		write;	// write pages to disk, else read them
+  Status	status;
+  bool		done;	// only looked at through AsyncIO::wait
+  struct iovec	one;	// iov of a single page request
+  long long	startNs; // when it was set up, 0 with metrics off
+  int		skip;	// iovecs already transferred (io_uring only)
+  size_t	moved;	// bytes already transferred (io_uring only)
+
+  // a single page
+  void set(File* f, const int p, Page* buf, const bool w)
+    {
+      one.iov_base = buf;
+      one.iov_len = sizeof(Page);
+      set(f, p, &one, 1, w);
+    }
+
+  // n pages; iov must stay valid until the request has completed,
+  // and the backend may step its entries past a short transfer
+  void set(File* f, const int p, struct iovec* v, const int n,
+	   const bool w)
+    {
+      file = f;
+      pageNo = p;
+      iov = v;
+      count = n;
+      write = w;
+      status = OK;
+      done = false;
+      skip = 0;
+      moved = 0;
+      startNs = metrics.enabled ? metricsNow() : 0;
+    }
+};
+
+struct IOStats
+{
+  std::atomic<long> submitted;	// requests handed to the backend
+  std::atomic<long> completed;	// requests finished
+  std::atomic<long> batches;	// calls to submit
+  std::atomic<long> syscalls;	// reads, writes and io_uring_enter calls
+  std::atomic<int> inFlight;	// requests submitted but not finished
+  std::atomic<int> maxInFlight;	// high-water mark of inFlight
+
+  void clear()
+    {
+      submitted = completed = batches = syscalls = 0;
+      maxInFlight = inFlight.load();
+    }
+
+  IOStats()
+    {
+      inFlight = 0;
+      clear();
+    }
+};
+
+
+// Page I/O under the buffer manager.  A batch of requests is
+// submitted at once and the requests may complete in any order;
+// each is waited for on its own.  Several threads may submit and
+// wait at the same time.  At most depth() requests are in flight,
+// submit blocks when the queue is full.
+class AsyncIO
+{
+public:
+  AsyncIO(const int depth) : qdepth(depth) {}
+  virtual ~AsyncIO() {}
+
+  virtual const char* name() const = 0;
+
+  // start the n requests in reqs.  On an error none of them is left
+  // in flight; those that were not started are done with UNIXERR.
+  virtual const Status submit(IORequest* reqs[], const int n) = 0;
+
+  // wait until req has completed, returns its status
+  virtual const Status wait(IORequest* req) = 0;
+
+  // submit the n requests in reqs and wait for all of them;
+  // returns the first error
+  const Status run(IORequest* reqs[], const int n);
+
+  int depth() const { return qdepth; }
+  const IOStats& getStats() const { return stats; }
+  void clearStats() { stats.clear(); }
+
+protected:
+  int qdepth;
+  IOStats stats;
+
+  static int unixFile(const File* file);
+  const Status transfer(IORequest* req);	// blocking pread/pwrite
+  void started(const int n);
+  void finished(const int n);
+  void completed(const IORequest* req);	// record its latency
+};
+
+// creates an I/O backend of the given kind.  AIO_AUTO and
+// AIO_URING fall back to the thread pool when the kernel does not
+// offer io_uring.
+AsyncIO* newAsyncIO(const IOBackend kind, const int depth = AIODEPTH);
+
+
+// Requests are done by the submitting thread before submit returns.
+// This is the old synchronous path, for comparison.
+class SyncIO : public AsyncIO
+{
+public:
+  SyncIO(const int depth) : AsyncIO(depth) {}
+
+  const char* name() const { return "sync"; }
+  const Status submit(IORequest* reqs[], const int n);
+  const Status wait(IORequest* req) { return req->status; }
+};
+
+
+// A pool of threads doing blocking pread/pwrite.
+class ThreadIO : public AsyncIO
+{
+public:
+  ThreadIO(const int depth);
+  ~ThreadIO();
+
+  const char* name() const { return "threads"; }
+  const Status submit(IORequest* reqs[], const int n);
+  const Status wait(IORequest* req);
+
+private:
+  std::deque<IORequest*> queue;		// requests not yet started
+  std::vector<std::thread> workers;
+  bool stop;
+  std::mutex latch;			// protects all of the above
+  std::condition_variable work;		// signalled when queue grows
+  std::condition_variable complete;	// signalled when requests finish
+
+  void worker();
+};
+
+
+// Linux io_uring, driven through the raw system calls.  There is
+// no completion thread: a thread waiting for a request reaps the
+// completion queue for everyone while the others sleep.
+class UringIO : public AsyncIO
+{
+public:
+  UringIO(const int depth, Status& status);
+  ~UringIO();
+
+  const char* name() const { return "io_uring"; }
+  const Status submit(IORequest* reqs[], const int n);
+  const Status wait(IORequest* req);
+
+private:
+  int ringFd;				// -1 if setup failed
+  unsigned entries;			// size of the submission queue
+  void* sqRing;				// mapped rings and their sizes
+  void* cqRing;
+  size_t sqRingSize, cqRingSize;
+  void* sqes;				// submission queue entries
+  size_t sqesSize;
+
+  // pointers into the mapped rings
+  unsigned *sqTail, *sqMask, *sqArray;
+  unsigned *cqHead, *cqTail, *cqMask;
+  void* cqes;
+
+  int pending;				// requests in the kernel
+  bool reaping;				// a thread is reaping completions
+  std::mutex latch;			// protects the rings and the above
+  std::condition_variable reaped;	// signalled after reaping
+
+  void queue(IORequest* req, unsigned& tail);
+  void reap(std::unique_lock<std::mutex>& lk);
+};
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef BTREE_H
+#define BTREE_H
+
+#include "heapfile.h"
+
+// A B+-tree over one attribute of the records of a heap file, the
+// attribute of length bytes at offset, compared like a scan filter of
+// its Datatype.  Entries are (key, RID) pairs kept in order of key,
+// then RID, so equal keys are allowed and every entry is unique.
+// Nodes are pages of the index file, read and written through the
+// buffer pool; leaves are chained left to right for range scans.
+// Deletes do not merge nodes: a leaf may end up empty and stay in
+// the tree until the index is rebuilt.
+//
+// The index lives in the file named by indexName and is listed in
+// the header page of the heap file, whose insertRecord, deleteRecord
+// and loaders keep it up to date.
+
+// first page of an index file
+struct IndexHdrPage
+{
+  char		relName[MAXNAMESIZE];	// heap file indexed
+  int		offset;			// attribute indexed
+  int		length;
+  Datatype	type;
+  int		rootPageNo;
+  int		height;			// levels, 1 when the root is a leaf
+  int		entryCnt;
+};
+
+// leaves a bulk build fills, in tenths
+const int BTREEFILL = 9;
+
+class BTreeIndex
+{
+public:
+  // open the index on the attribute at offset of heap file relName
+  BTreeIndex(const string& relName, const int offset, Status& status);
+
+  // ends the scan and closes the index file
+  ~BTreeIndex();
+
+  // the name of the file of that index
+  static const string indexName(const string& relName, const int offset);
+
+  // add or remove the entry of the record at rid whose attribute
+  // value is at key; deleteEntry returns RECNOTFOUND if it is absent
+  const Status insertEntry(const void* key, const RID& rid);
+  const Status deleteEntry(const void* key, const RID& rid);
+
+  // scan for the entries with keys above lowVal (lowOp GT or GTE)
+  // and below highVal (highOp LT or LTE); a NULL value leaves that
+  // end of the range open
+  const Status startScan(const void* lowVal, const Operator lowOp,
+			 const void* highVal, const Operator highOp);
+
+  // RID of the next entry of the scan, NOMORERECS after the last
+  const Status scanNext(RID& outRid);
+
+  const Status endScan();
+
+  const int getEntryCnt() const { return header->entryCnt; }
+  const int getHeight() const { return header->height; }
+
+  // fill an empty index with n entries, each length bytes of key
+  // followed by its RID, sorting them first
+  const Status build(vector<char>& entries, const int n);
+
+private:
+  File*		file;
+  IndexHdrPage*	header;		// pinned header page
+  int		headerPageNo;
+  bool		hdrDirty;
+  int		keyLen;
+  int		leafSize;	// bytes of a leaf entry
+  int		innerSize;	// bytes of an inner node entry
+  int		leafCap;	// entries a node can hold
+  int		innerCap;
+
+  // scan state
+  bool		scanning;
+  Page*		scanPage;	// pinned leaf of the scan, or NULL
+  int		scanPageNo;
+  int		scanPos;	// next entry of that leaf
+  vector<char>	highKey;	// copy of highVal
+  bool		highOpen;
+  Operator	highOp;
+
+  // reused by insertEntry for the entry added to a node and the
+  // separator key a split passes up; one of each does for every level
+  vector<char>	addBuf;		// innerSize bytes
+  vector<char>	sepBuf;		// keyLen bytes
+
+  const int compareKeys(const char* a, const char* b) const;
+  const int compare(const char* a, const RID& ra, const char* b,
+		    const RID& rb) const;
+  const int childFor(const char* node, const char* key,
+		     const RID& rid) const;
+  const int leafPos(const char* node, const char* key,
+		    const RID& rid) const;
+  const Status findLeaf(const char* key, const RID& rid, int& pageNo,
+			Page*& page);
+  const Status insert(const int pageNo, const char* key, const RID& rid,
+		      bool& split, char* sepKey, RID& sepRid,
+		      int& sepPageNo);
+  const Status newNode(const int level, int& pageNo, Page*& page);
+};
+
+// create the index on the attribute of length bytes at offset of the
+// records of heap file relName, bulk built from its records, and list
+// it in the file's header page
+const Status createIndex(const string relName, const int offset,
+			 const int length, const Datatype type);
+
+// remove that index from the heap file and destroy its file
+const Status destroyIndex(const string relName, const int offset);
+
+#endif
@@ -1,31 +1,99 @@
 #ifndef BUF_H
 #define BUF_H
 
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <deque>
+#include <vector>
 #include "db.h"
+#include "bufPolicy.h"
+#include "aio.h"
 // define if debug output wanted
 //#define DEBUGBUF
 
-// declarations for buffer pool hash table
-struct hashBucket
+// number of latches guarding the buffer pool hash table
+const int HTLATCHES = 64;
+
+// number of sequential streams tracked for read-ahead, and the
+// number of consecutive pages that make a stream sequential
+const int RASTREAMS = 16;
+const int RATRIGGER = 2;
+
+// most threads reading ahead at once
+const int RATHREADS = 4;
+
+// most pages a read-ahead worker reads with one submission
+const int RABATCH = 16;
+
+// most pages written back with one system call
+const int WRITERUN = 32;
+
+// most pages BufMgr::writeBack copies out and writes at a time
+const int WRITEBATCH = 8 * WRITERUN;
+
+// milliseconds the background writer sleeps between rounds
+const int BGINTERVAL = 10;
+
+// one entry of the buffer pool hash table.  file == NULL marks an
+// empty slot.
+struct hashSlot
 {
 	File*	file;    // pointer a file object (more on this below)
 	int	pageNo;  // page number within a file
 	int	frameNo; // frame number of page in the buffer pool
-	hashBucket* 	next;	 // next node in the hash table
+};
+
+// latch padded to its own cache line
+struct alignas(64) hashLatch
+{
+	std::mutex m;
 };
 
 
-// hash table to keep track of pages in the buffer pool
+// hash table to keep track of pages in the buffer pool.
+// Open addressing with linear probing over a flat array that is
+// allocated once, so buffer misses do no memory allocation.  The
+// array is split into HTLATCHES partitions of equal size, each with
+// its own latch; probe sequences never leave their partition.
+// Callers must hold latch(file,pageNo) around insert, lookup and
+// remove when the buffer pool is shared between threads.
 class BufHashTbl
 {
 private:
-    int HTSIZE;
-    hashBucket**  ht; // actual hash table
-    int	 hash(const File* file, const int pageNo); // returns value between 0 and HTSIZE-1
+    int		partSize;	// slots per partition, a power of two
+    hashSlot*	ht;		// actual hash table, HTLATCHES*partSize slots
+    hashLatch*	latches;	// one latch per partition of ht
+
+    // mixes (file,pageNo) into 64 bits.  The top bits select the
+    // partition, the low bits the home slot within it.
+    static unsigned long long hash(const File* file, const int pageNo)
+    {
+      unsigned long long h = (unsigned long long) file;
+      h = h * 0x9e3779b97f4a7c15ULL + (unsigned int) pageNo;
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdULL;
+      h ^= h >> 33;
+      h *= 0xc4ceb9fe1a85ec53ULL;
+      h ^= h >> 33;
+      return h;
+    }
+    static int partition(const unsigned long long h)
+    {
+      return (int) (h % HTLATCHES);
+    }
 
 public:
-    BufHashTbl(const int htSize);  // constructor
+    BufHashTbl(const int bufs);  // constructor, sized for bufs frames
     ~BufHashTbl(); // destructor
+
+    // returns the latch of the partition holding (file,pageNo)
+    std::mutex& latch(const File* file, const int pageNo)
+    {
+      return latches[partition(hash(file, pageNo))].m;
+    }
 	
     // insert entry into hash table mapping (file,pageNo) to frameNo;
     // returns 0 if OK, HASHTBLERROR if an error occurred
@@ -44,17 +112,24 @@ public:
 
 class BufMgr;  //forward declaration of BufMgr class 
 
-// class for maintaining information about buffer pool frames
+// class for maintaining information about buffer pool frames.
+// pinCnt, dirty and valid are atomic so that hits and
+// unpins never need more than the hash partition latch.  file and
+// pageNo only change under latch, while the frame is pinned by the
+// thread that is replacing its contents.
 class BufDesc {
     friend class BufMgr;
+    friend class BufPolicy;
 private:
   File* file;   // pointer to file object
   int   pageNo; // page within file
   int	frameNo;  // frame # of frame
-  int   pinCnt; // number of times this page has been pinned
-  bool 	dirty;	  // true if dirty;  false otherwise
-  bool 	valid;   // true if page is valid
-  bool  refbit;	 // has this buffer frame been reference recently
+  std::atomic<int>  pinCnt; // number of times this page has been pinned
+  std::atomic<bool> dirty;	  // true if dirty;  false otherwise
+  std::atomic<bool> valid;   // true if page is valid
+  std::atomic<bool> ioPending; // being read in, or copied out to be written
+  std::atomic<bool> prefetched; // read ahead and not yet asked for
+  std::mutex latch;	 // held while the frame is being claimed
 
   void Clear() {  // initialize buffer frame for a new user
     	pinCnt = 0;
@@ -62,6 +137,8 @@ private:
 	pageNo = -1;
     	dirty = false;
 	valid = false;
+	ioPending = false;
+	prefetched = false;
   };
 
   void Set(File* filePtr, int pageNum) { 
@@ -70,10 +147,11 @@ private:
       pinCnt = 1;
       dirty = false;
       valid = true;
-      refbit = true;
+      prefetched = false;
   }
 
   BufDesc() {
+      frameNo = -1;
       Clear();
   }
 };
@@ -81,13 +159,47 @@ private:
 
 struct BufStats
 {
-  int accesses;    // Total number of accesses to buffer pool
-  int diskreads;   // Number of pages read from disk (including allocs)
-  int diskwrites;  // Number of pages written back to disk
+  std::atomic<long> hits;        // Accesses that found the page in the pool
+  std::atomic<long> misses;      // Accesses that had to read the page
+  std::atomic<long> diskreads;   // Number of pages read from disk (including allocs)
+  std::atomic<long> diskwrites;  // Number of pages written back to disk
+  std::atomic<long> writeCalls;  // Writes issued for them, one per run of pages
+  std::atomic<long> fgWrites;    // Pages written while evicting, for a caller
+  std::atomic<long> bgWrites;    // Pages written by the background writer
+  std::atomic<long> evictions;   // Pages replaced to make room for others
+  std::atomic<long> dirtyEvictions; // Of them, written back first
+  std::atomic<long> pinWaits;    // Waits for a page another thread was reading
+  std::atomic<long> prefetches;  // Pages read ahead of a sequential scan
+  std::atomic<long> prefetchHits;   // Accesses to a page that was read ahead
+  std::atomic<long> prefetchMisses; // Sequential accesses that missed anyway
+  std::atomic<long> prefetchUnused; // Pages read ahead but evicted unused
+  std::atomic<long> mappedReads; // Accesses served from a file's mapping
 
   void clear()
     {
-      accesses = diskreads = diskwrites = 0;
+      hits = misses = diskreads = diskwrites = writeCalls = 0;
+      fgWrites = bgWrites = evictions = dirtyEvictions = pinWaits = 0;
+      prefetches = prefetchHits = prefetchMisses = prefetchUnused = 0;
+      mappedReads = 0;
+    }
+
+  // total number of successful accesses to the buffer pool
+  long accesses() const
+    {
+      return hits + misses + mappedReads;
+    }
+
+  // fraction of accesses served from the pool
+  double hitRatio() const
+    {
+      long n = accesses();
+      return n > 0 ? (double) hits / n : 0.0;
+    }
+
+  // write system calls per page written back
+  double callsPerWrite() const
+    {
+      return diskwrites > 0 ? (double) writeCalls / diskwrites : 0.0;
     }
       
   BufStats()
@@ -97,27 +209,93 @@ struct BufStats
 };
 
 
+// a run of accesses to consecutive pages of one file
+struct readAheadStream
+{
+  const File*	file;	  // NULL if the entry is unused
+  int		lastPage; // page accessed last
+  int		run;	  // number of consecutive pages seen
+  int		ahead;	  // highest page requested for read-ahead
+  unsigned long	used;	  // for replacing the least recently used entry
+};
+
+
+// The buffer manager may be shared by several threads.  Lookups
+// latch one partition of the hash table and pins are atomic, so
+// there is no lock covering the whole pool.  Which page to replace
+// is decided by a BufPolicy chosen at construction.  Pages of a
+// mapped file (see File) take no frame: readPage returns a pointer
+// into the mapping, and pins are only counted per file, so that
+// flushFile can report PAGEPINNED.
 class BufMgr 
 {
 private:
-  unsigned int 	 clockHand;
   int   	 numBufs;    	// Number of pages in buffer pool
   BufHashTbl*    hashTable;  	// hash table mapping (File, page) to frame
   BufDesc*	 bufTable;  	// vector of status info, 1 per page
   BufStats	 bufStats;	// buffer pool statistics
+  BufPolicy*	 policy;	// page replacement policy
+  AsyncIO*	 aio;		// does all page reads and writes
+
+  std::mutex	 ioMutex;	// used with ioDone to wait for reads
+  std::condition_variable ioDone;
+  std::atomic<int> ioWaiters;	// threads sleeping on ioDone
+
+  // read-ahead: pages after a sequential run are queued and read
+  // into unpinned frames by worker threads
+  int		 readAhead;	// pages to read ahead, 0 if disabled
+  readAheadStream raStreams[RASTREAMS];
+  unsigned long	 raClock;
+  std::deque<std::pair<File*, int> > raQueue;  // pages to read ahead
+  File*		 raBusy[RATHREADS];	// file each worker is reading
+  std::vector<std::thread> raWorkers;
+  bool		 raStop;
+  std::mutex	 raMutex;	// protects all of the above
+  std::condition_variable raWork;  // signalled when raQueue grows
+  std::condition_variable raIdle;  // signalled when a worker finishes
+
+  // background writer: keeps bgTarget of the frames next in line
+  // for replacement clean
+  int		 bgTarget;	// 0 if there is no writer
+  std::thread	 bgThread;
+  bool		 bgStop;
+  std::mutex	 bgMutex;	// protects bgStop
+  std::condition_variable bgWake;  // signalled on foreground writes
 
   const Status allocBuf(int & frame);   // allocate a free frame.  
-  const void releaseBuf(int frame); // return unused frame to end of list
-  void advanceClock()
-  {
-	clockHand = (clockHand + 1) % numBufs;
-  }
+  const Status evictFrame(const int frame); // drop page from a latched frame
+  void releaseBuf(int frame); // return unused frame to end of list
+  void waitForIO(const int frame);  // wait until frame has been read in
+  void finishIO(const int frame);   // wake up threads waiting on frame
+  const Status pageIO(const int frame, const bool write);  // frame <-> disk
+  const Status writeBack(std::vector<int>& frames);  // batch of writes
+  bool claimDirty(File* file, const int pageNo, std::vector<int>& frames);
+  bool claimFrame(const int frame, std::vector<int>& frames);
+
+  // enter (file,pageNo) in a new frame, pinned and with ioPending
+  // set, for the caller to read in; frameNo is -1 if the page turned
+  // up in the pool meanwhile
+  const Status claimRead(File* file, const int pageNo, int& frameNo);
+  void finishRead(const int frame, const Status status);
+
+  // pin (file,pageNo), reading it in if needed; hit tells which
+  const Status fetchPage(File* file, const int pageNo, int& frameNo,
+			 bool& hit);
+  void noteAccess(File* file, const int pageNo, const bool hit);
+  void readAheadWorker(const int id);
+  void readAheadRun(File* file, const int pageNo, const int n);
+  void cancelReadAhead(const File* file);  // drop pending read-ahead
+  void stopReadAhead();
+  void bgWriter();
+  void writeAhead();		// one round of the background writer
+  void stopBgWriter();
 
 
 public:
   Page*	         bufPool;   // actual buffer pool
 
-  BufMgr(const int bufs);
+  BufMgr(const int bufs, const ReplPolicy replPolicy = CLOCK,
+	 const IOBackend ioBackend = AIO_AUTO);
   ~BufMgr();
 
   const Status readPage(File* file, const int PageNo, Page*& page);
@@ -125,8 +303,21 @@ public:
   const Status allocPage(File* file, int& PageNo, Page*& page); 
                         // allocates a new, empty page 
   const Status flushFile(const File* file); // writing out all dirty pages of the file
-  const Status disposePage(File* file, const int PageNo); // dispose of page in file
-  void  printSelf();
+  const Status disposePage(File* file, const int PageNo); // dispose of page in file,
+                        // PAGEPINNED if it is in use
+  void  printSelf();  // the frames and what they hold
+
+  // read up to pages pages ahead of sequential access, 0 to disable
+  void setReadAhead(const int pages);
+
+  // write back dirty pages in the background, keeping the next
+  // frames frames in line for replacement clean; 0 to disable
+  void setBgWriter(const int frames);
+
+  const char* policyName() const // name of the replacement policy
+  {
+	return policy->name();
+  }
 
   const BufStats & getBufStats() const // get buffer pool usage
   {
@@ -135,8 +326,18 @@ public:
   const void clearBufStats() 
   {
 	bufStats.clear();
+	aio->clearStats();
+  }
+
+  const char* ioName() const // name of the I/O backend
+  {
+	return aio->name();
+  }
+
+  const IOStats & getIOStats() const // requests submitted and in flight
+  {
+	return aio->getStats();
   }
 };
 
 #endif
-
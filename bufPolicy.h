@@ -0,0 +1,197 @@
+#ifndef BUFPOLICY_H
+#define BUFPOLICY_H
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "db.h"
+
+class BufDesc;
+
+// page replacement policies of the buffer manager
+enum ReplPolicy { CLOCK, LRUK, TWOQ };
+
+// Interface between the buffer manager and a page replacement
+// policy.  The buffer manager reports every hit, load and drop of a
+// page and asks the policy for candidate frames when it needs one.
+// A candidate may turn out to be unusable (pinned, or claimed by
+// another thread); the buffer manager then hands it back through
+// restore() and asks again.  All methods may be called from several
+// threads at once.
+class BufPolicy
+{
+public:
+  BufPolicy(const int bufs, const BufDesc* table)
+    : numBufs(bufs), bufTable(table) {}
+  virtual ~BufPolicy() {}
+
+  virtual const char* name() const = 0;
+
+  // the page in frame was found in the pool
+  virtual void accessed(const int frame) = 0;
+
+  // frame now holds (file,pageNo), read from disk or newly allocated
+  virtual void loaded(const int frame, const File* file, const int pageNo) = 0;
+
+  // the page (file,pageNo) was replaced by the caller of victim()
+  virtual void evicted(const int frame, const File* file, const int pageNo) = 0;
+
+  // frame no longer holds a page (flushed, disposed or never filled)
+  virtual void freed(const int frame) = 0;
+
+  // returns the next frame to try to replace
+  virtual int victim() = 0;
+
+  // a frame returned by victim() could not be used
+  virtual void restore(const int frame) = 0;
+
+  // appends up to n frames that victim() is likely to return next,
+  // in that order, without claiming them
+  virtual void upcoming(const int n, std::vector<int>& frames) = 0;
+
+protected:
+  int numBufs;
+  const BufDesc* bufTable;
+
+  const bool pinned(const int frame) const;  // frame is in use
+};
+
+// creates the policy of the given kind for a pool of bufs frames
+BufPolicy* newBufPolicy(const ReplPolicy kind, const int bufs,
+			const BufDesc* table);
+
+
+// The classic clock algorithm.  Reference bits are atomic and the
+// hand is advanced with an atomic increment, so neither hits nor
+// the sweep take a lock.
+class ClockPolicy : public BufPolicy
+{
+public:
+  ClockPolicy(const int bufs, const BufDesc* table);
+  ~ClockPolicy();
+
+  const char* name() const { return "clock"; }
+  void accessed(const int frame);
+  void loaded(const int frame, const File* file, const int pageNo);
+  void evicted(const int frame, const File* file, const int pageNo) {}
+  void freed(const int frame);
+  int victim();
+  void restore(const int frame) {}
+  void upcoming(const int n, std::vector<int>& frames);
+
+private:
+  std::atomic<unsigned int> clockHand;
+  std::atomic<bool>* refbit;	// has this frame been referenced recently
+};
+
+
+// LRU-K (O'Neil, O'Neil and Weikum).  Replaces the page whose K-th
+// most recent reference is oldest; pages referenced fewer than K
+// times go first, in LRU order.  A page touched once by a large
+// scan therefore never displaces pages that are probed repeatedly.
+// Hits only note the time in the frame, without the latch; victim()
+// moves a frame with such notes back in the order when it comes
+// across it.  Hits never make a page older, so the frames it does
+// not reach need no such care.
+class LRUKPolicy : public BufPolicy
+{
+public:
+  LRUKPolicy(const int bufs, const BufDesc* table, const int k = 2);
+  ~LRUKPolicy();
+
+  const char* name() const { return "lru-k"; }
+  void accessed(const int frame);
+  void loaded(const int frame, const File* file, const int pageNo);
+  void evicted(const int frame, const File* file, const int pageNo) {}
+  void freed(const int frame);
+  int victim();
+  void restore(const int frame);
+  void upcoming(const int n, std::vector<int>& frames);
+
+private:
+  // (K-th most recent reference, most recent reference), 0 if none
+  typedef std::pair<unsigned long, unsigned long> Key;
+
+  int K;
+  std::atomic<unsigned long> clock; // logical time, one tick per load
+  unsigned long* history;	// last K reference times of each frame
+  std::atomic<unsigned long>* hitTime; // of the last unsettled hit
+  std::atomic<int>* hits;	// hits since the frame was last settled
+  int* where;			// list a frame is on, see bufPolicy.C
+  std::set<std::pair<Key, int> > order;  // resident frames, victim first
+  std::list<int> freeFrames;
+  std::mutex latch;
+
+  Key key(const int frame) const;
+  void touch(const int frame);
+  bool settle(const int frame);	// fold hits into the history
+  bool reorder(std::set<std::pair<Key, int> >::iterator& it);
+};
+
+
+// 2Q (Johnson and Shasha).  Pages enter a FIFO queue A1in; a page
+// evicted from A1in is remembered in the ghost queue A1out.  Only a
+// page referenced again, while in A1in or remembered in A1out, is
+// promoted to the LRU queue Am.  A sequential scan passes through
+// A1in without touching the hot pages in Am.  A hit only sets a flag
+// in the frame; the frame is moved to Am when victim() or upcoming()
+// reaches it at the old end of its queue.
+class TwoQPolicy : public BufPolicy
+{
+public:
+  TwoQPolicy(const int bufs, const BufDesc* table);
+  ~TwoQPolicy();
+
+  const char* name() const { return "2q"; }
+  void accessed(const int frame);
+  void loaded(const int frame, const File* file, const int pageNo);
+  void evicted(const int frame, const File* file, const int pageNo);
+  void freed(const int frame);
+  int victim();
+  void restore(const int frame);
+  void upcoming(const int n, std::vector<int>& frames);
+
+private:
+  enum Queue { NONE, FREE, A1IN, AM };
+
+  struct PageKey
+  {
+    const File* file;
+    int pageNo;
+    bool operator==(const PageKey& other) const
+    {
+      return file == other.file && pageNo == other.pageNo;
+    }
+  };
+  struct PageKeyHash
+  {
+    size_t operator()(const PageKey& k) const
+    {
+      return std::hash<const void*>()(k.file) * 31 + k.pageNo;
+    }
+  };
+
+  int kin;			// target size of A1in
+  int kout;			// size of A1out
+  int* prev;			// doubly linked queues threaded through
+  int* next;			//   the frames, head is most recent
+  Queue* queue;			// queue each frame is on
+  Queue* taken;			// queue a frame was taken from by victim()
+  std::atomic<bool>* hit;	// referenced since it was last looked at
+  int head[4], tail[4], size[4];
+  std::list<PageKey> a1out;	// ghost queue, front is most recent
+  std::unordered_map<PageKey, std::list<PageKey>::iterator,
+		     PageKeyHash> ghosts;
+  std::mutex latch;
+
+  void link(const int frame, const Queue q);   // add at head of q
+  void unlink(const int frame);                // remove from its queue
+  bool promote(const int frame);	// to Am, if it has been hit
+  int oldestUnpinned(const Queue q);
+};
+
+#endif
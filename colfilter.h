@@ -0,0 +1,33 @@
+#ifndef COLFILTER_H
+#define COLFILTER_H
+
+#include <stdint.h>
+#include "heapfile.h"
+
+// Comparison of a column of attribute values, gathered from the
+// records of a page, with a constant.  The result is a bitmap with
+// one bit per value; values that fail the comparison have their bit
+// cleared and the other bits are left alone, so that the terms of a
+// conjunction can be applied one after the other.
+
+// instruction sets the comparisons can use
+enum SimdLevel { SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2 };
+
+// the best level this processor offers
+SimdLevel simdSupported();
+
+// the level in use, the best supported unless lowered by
+// setSimdLevel (for comparisons)
+SimdLevel simdLevel();
+void setSimdLevel(const SimdLevel level);
+const char* simdName(const SimdLevel level);
+
+// words of a bitmap of n values
+inline int bitmapWords(const int n) { return (n + 63) / 64; }
+
+void filterInts(const int vals[], const int n, const Operator op,
+		const int value, uint64_t bits[]);
+void filterFloats(const float vals[], const int n, const Operator op,
+		  const float value, uint64_t bits[]);
+
+#endif
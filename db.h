@@ -2,8 +2,11 @@
 #define DB_H
 
 #include <sys/types.h>
+#include <atomic>
 #include <functional>
+#include <mutex>
 #include "error.h"
+#include "metrics.h"
 #include <string.h>
 using namespace std;
 
@@ -15,20 +18,54 @@ using namespace std;
 // forward class definition for db
 class DB;
 
-// class definition for open files
+// a file that runs out of allocated space grows by an eighth of its
+// size, but by no less than EXTENTMIN and no more than EXTENTMAX
+// bytes, so that small files such as temporary runs stay small and
+// large ones are not extended a few pages at a time
+const int EXTENTMIN = 16 * 1024;
+const int EXTENTMAX = 8 * 1024 * 1024;
+
+// structure of DB (header) page
+
+typedef struct {
+  int nextFree;                         // page # of next page on free list
+  int firstPage;                        // page # of first page in file
+  int numPages;                         // total # of pages in file
+  int pageSize;                         // PAGESIZE of the build that created it
+} DBPage;
+
+// class definition for open files.  A file opened mapped is
+// read-only: its pages are mapped into memory and the buffer manager
+// hands out pointers into the mapping instead of copying them into
+// frames.  Allocating, disposing of and writing pages return
+// FILEREADONLY.
 class File {
   friend class DB;
   friend class OpenFileHashTbl;
+  friend class AsyncIO;
+  friend class BufMgr;
 
  public:
 
   Status allocatePage(int& pageNo);     // allocate a new page
+  Status allocatePages(const int n,
+		       int& firstPageNo);   // allocate n pages at the end
   const Status disposePage(const int pageNo);       // release space for a page
   const Status readPage(const int pageNo,
 		  Page* pagePtr) const;       // read page from file
   const Status writePage(const int pageNo,
 		   const Page* pagePtr);      // write page to file
+  const Status writePages(const int pageNo, const Page* pages,
+		    const int n);             // write n consecutive pages
   const Status getFirstPage(int& pageNo) const;     // returns pageNo of first page
+  int getPageCount() const;             // pages allocated, header included
+  const Status flushHeader();           // write back the cached header
+  const Status sync();                  // force the pages written to disk
+  const string& getName() const { return fileName; }
+
+  bool isMapped() const { return mapping != NULL; }
+  Page* mappedPage(const int pageNo) const;  // NULL if out of range
+  void advise(const int advice) const;  // madvise the whole mapping
 
   bool operator == (const File & other) const
     {
@@ -43,7 +80,7 @@ class File {
   static const Status create(const string &fileName);
   static const Status destroy(const string &fileName);
 
-  const Status open();
+  const Status open(const bool mapped);
   const Status close();
 
   const Status intread(const int pageNo,
@@ -55,9 +92,25 @@ class File {
   void listFree();                      // list free pages
 #endif
 
+  const Status extend(const int pages);  // make room for pages pages
+  const int extentPages() const;        // pages of the next extent
+
   string fileName;                    // The name of the file
   int openCnt;                        // # times file has been opened
   int unixFile;                       // unix file stream for file
+
+  // The header page is read on open and kept here; it is written
+  // back by flushHeader, at the latest when the file is closed.
+  DBPage header;
+  bool hdrDirty;                      // header differs from page 0
+  int extentEnd;                      // pages the unix file has room for
+  mutable std::mutex hdrLatch;        // protects the three above
+
+  char* mapping;                      // of the pages when mapped, else NULL
+  int mappedPages;                    // pages in the mapping
+  std::atomic<int> mapPins;           // pages of it pinned, for BufMgr
+
+  FileMetrics* counters;              // of the file, see metrics.h
 };
 
 class BufMgr;
@@ -98,6 +151,9 @@ public:
 
 
 
+// Opening and closing files is serialized by a latch, so that
+// several threads may open scans on the same file.
+
 class DB {
  public:
   DB();                                 // initialize open file table
@@ -106,20 +162,17 @@ class DB {
   const Status createFile(const string & fileName) ;  // create a new file
   const Status destroyFile(const string & fileName) ; // destroy a file, 
                                                            // release all space
-  const Status openFile(const string & fileName, File* & file);  // open a file
+  // open a file.  mapped asks for a read-only mapped file, see File;
+  // if the file is already open for writing it is shared as it is.
+  // Returns FILEREADONLY if it is open mapped and mapped is false.
+  const Status openFile(const string & fileName, File* & file,
+			const bool mapped = false);
   const Status closeFile(File* file);         // close a file
 
  private:
   OpenFileHashTbl   openFiles;    // list of open files
+  std::mutex	    latch;	  // protects openFiles and open counts
 };
 
 
-// structure of DB (header) page
-
-typedef struct {
-  int nextFree;                         // page # of next page on free list
-  int firstPage;                        // page # of first page in file
-  int numPages;                         // total # of pages in file
-} DBPage;
-
 #endif
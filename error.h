@@ -17,7 +17,8 @@ enum Status {
 // File and DB errors
 
        BADFILEPTR, BADFILE, FILETABFULL, FILEOPEN, FILENOTOPEN,
-       UNIXERR, BADPAGEPTR, BADPAGENO, FILEEXISTS,
+       UNIXERR, BADPAGEPTR, BADPAGENO, FILEEXISTS, BADPAGESIZE,
+       FILEREADONLY,
 
 // BufMgr and HashTable errors
 
@@ -40,6 +41,10 @@ enum Status {
 // SortedFile errors
  
        BADSORTPARM, INSUFMEM, 
+
+// Log errors
+
+       BADLOG, LOGMISMATCH,
 	
 // Catalog errors
 
@@ -0,0 +1,67 @@
+#ifndef FSM_H
+#define FSM_H
+
+#include "page.h"
+#include "buf.h"
+
+// The free-space map of a heap file keeps one byte per page of the
+// file, the free space of that page in units of FSMUNIT bytes,
+// rounded down.  A page whose byte is at least the size of a record
+// in those units (rounded up) has room for the record.  The bytes
+// live on map pages allocated in the file like any other page; map
+// page k covers pages k*FSMSLOTS to (k+1)*FSMSLOTS-1.  Pages that
+// are not data pages (the header and the map pages themselves) and
+// data pages that have not been seen yet are FSMNONE.
+//
+// The map is approximate: it is only updated by the heap file
+// methods that change a page, so a page can have more room than its
+// byte says, never less unless another open scan of the file has
+// filled it.  Callers must check the page itself.  Map pages are
+// not logged; recovery rebuilds the map.
+
+const int FSMSLOTS = PAGESIZE - sizeof(LSN);	// pages covered by a map page
+const int FSMUNIT = (PAGESIZE - 1) / 254 + 1;	// bytes per unit
+const unsigned char FSMNONE = 255;		// not a data page
+const int FSMDIRSIZE = 200;			// most map pages of a file
+
+// the map's directory, kept in the header page of the heap file
+struct FSMDir
+{
+  int		cnt;			// number of map pages
+  int		hint;			// first page that may have room
+  int		pages[FSMDIRSIZE];	// page numbers of the map pages
+};
+
+class FreeSpaceMap
+{
+public:
+  FreeSpaceMap();
+  ~FreeSpaceMap();
+
+  // use the map of file whose directory is dir.  hdrDirty is set
+  // whenever the directory changes.
+  void attach(File* file, FSMDir* dir, bool* hdrDirty);
+
+  // pageNo now has freeSpace bytes free
+  const Status update(const int pageNo, const int freeSpace);
+
+  // returns a data page that had room for a record of length bytes,
+  // or FILEEOF if there is none
+  const Status find(const int length, int& pageNo);
+
+  // unpin the map page held, if any
+  const Status release();
+
+private:
+  File*		file;
+  FSMDir*	dir;
+  bool*		hdrDirty;
+  int		heldIndex;	// index in dir of the pinned map page, or -1
+  unsigned char* held;		// contents of that page
+  bool		heldDirty;
+
+  const Status hold(const int index);
+  const Status grow(const int index);
+};
+
+#endif
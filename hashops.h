@@ -0,0 +1,203 @@
+#ifndef HASHOPS_H
+#define HASHOPS_H
+
+#include "heapfile.h"
+
+// records read from a heap file at a time
+const int HASHBATCH = 256;
+
+// bytes an Arena takes from the heap at a time
+const int ARENABLOCK = 64 * 1024;
+
+// times a partition too big for memory is split again before it is
+// processed regardless of the budget
+const int HASHDEPTH = 3;
+
+// Allocates many small pieces of memory out of large blocks, and
+// frees them all at once.  Pieces are 8-byte aligned.
+class Arena
+{
+public:
+  Arena(const int blockSize = ARENABLOCK);
+  ~Arena();
+
+  void* alloc(const int bytes);
+
+  // give back all pieces, keeping the blocks for reuse
+  void reset();
+
+  // bytes handed out since the last reset
+  const long used() const { return inUse; }
+
+private:
+  vector<char*>	blocks;
+  vector<int>	sizes;			// of blocks
+  int		blockSize;
+  int		cur;			// block being carved
+  int		pos;			// next free byte of it
+  long		inUse;
+};
+
+// hash of the attribute of length bytes at p, consistent with
+// compareAttr: values it finds equal hash the same
+const unsigned hashAttr(const char* p, const int length,
+			const Datatype type, const unsigned seed);
+
+// Equijoin of two heap files on an attribute of length bytes and one
+// Datatype, at buildOffset in the records of buildName and probeOffset
+// in those of probeName.  The records of the build file go into a
+// hash table in memory, then each record of the probe file is looked
+// up in it.  Records too short to hold the attribute, and NaN floats,
+// match nothing.
+//
+// The table may take frames pages less the two the probe scan pins.
+// When the build file does not fit, both files are split by a hash of
+// the attribute into partitions, temporary heap files, enough for the
+// build file's to fit by an estimate from the records read so far but
+// no more than the budget has room to write at once.  The partitions
+// are joined pairwise; a build partition still too big is split
+// again, up to HASHDEPTH times.
+class HashJoin
+{
+public:
+  HashJoin(const string& buildName, const int buildOffset,
+	   const string& probeName, const int probeOffset, const int length,
+	   const Datatype type, const int frames, Status& status);
+
+  // removes the partitions left
+  ~HashJoin();
+
+  // the next pair of matching records, valid until the next call;
+  // FILEEOF after the last one
+  const Status next(Record& buildRec, Record& probeRec);
+
+  // partitions written, 0 when the build file fitted in memory
+  const int partitionCount() const { return partitions; }
+
+private:
+  struct Entry
+  {
+    Entry*	next;			// in the chain of its bucket
+    unsigned	hash;
+    int		length;			// of the record following
+  };
+
+  // a pair of partitions still to be joined
+  struct Part
+  {
+    string	build;
+    string	probe;
+    int		depth;			// splits that made it
+  };
+
+  string	buildName, probeName;
+  int		buildOffset, probeOffset;
+  int		length;
+  Datatype	type;
+  int		budget;			// bytes of the table
+  int		fanOut;			// most partitions written at a time
+  int		partitions;
+  long		estimate;		// bytes the file a build gave up on
+					// would take
+
+  Arena		arena;
+  vector<Entry*> table;
+  int		entries;
+
+  vector<Part>	parts;			// still to be joined
+  Part		current;		// being joined; temporary if depth > 0
+  HeapFileScan*	probe;
+  RID		rids[HASHBATCH];
+  Record	recs[HASHBATCH];
+  int		count;
+  int		pos;			// current probe record of recs
+  const char*	probeKey;		// its attribute, NULL if none
+  unsigned	probeHash;
+  Entry*	match;			// last match of it returned
+
+  const Status build(const string& name, const bool bounded, bool& fits);
+  const Status start(Part part);
+  const Status split(const Part& part);
+  void setProbe();
+  void finish();
+  const bool keyOf(const Record& rec, const int offset,
+		   const char*& key) const;
+};
+
+// aggregates of an attribute over the records of a group
+enum AggOp { AGGCOUNT, AGGSUM, AGGMIN, AGGMAX };
+
+// one aggregate to compute: the INTEGER or FLOAT attribute at offset
+// (ignored by AGGCOUNT) and its aggregate
+struct AggTerm
+{
+  int		offset;
+  Datatype	type;
+  AggOp		op;
+};
+
+// GROUP BY of the records of a heap file on the attribute of length
+// bytes at offset, computing aggs over each group.  Groups are kept
+// in a hash table in memory of up to frames pages less the two the
+// scan pins; if they do not fit, the file is split into partitions by
+// a hash of the attribute as HashJoin splits its build file, and each
+// partition is grouped on its own.  Records too short to hold the
+// attribute or one of those aggregated are left out.
+class HashAggregate
+{
+public:
+  HashAggregate(const string& fileName, const int offset, const int length,
+		const Datatype type, const vector<AggTerm>& aggs,
+		const int frames, Status& status);
+
+  // removes the partitions left
+  ~HashAggregate();
+
+  // the next group: the length bytes of its attribute followed by a
+  // double for each of aggs, unaligned; valid until the next call.
+  // FILEEOF after the last group
+  const Status next(Record& rec);
+
+  // partitions written, 0 when all groups fitted in memory
+  const int partitionCount() const { return partitions; }
+
+private:
+  struct Group
+  {
+    Group*	next;			// in the chain of its bucket
+    unsigned	hash;
+  };
+
+  struct Part
+  {
+    string	name;
+    int		depth;
+  };
+
+  string	fileName;
+  int		offset;
+  int		length;
+  Datatype	type;
+  vector<AggTerm> aggs;
+  int		minLength;		// of a record aggregated
+  int		budget;
+  int		fanOut;
+  int		partitions;
+  long		estimate;
+
+  Arena		arena;
+  vector<Group*> table;
+  int		groups;
+  int		bucket;			// of the group returned last
+  Group*	group;
+
+  vector<Part>	parts;
+  Part		current;
+
+  const Status build(const Part& part, const bool bounded, bool& fits);
+  const Status start();
+  const Status split(const Part& part);
+  void add(Group* g, const Record& rec, const bool first);
+};
+
+#endif
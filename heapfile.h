@@ -2,6 +2,7 @@
 #define HEAPFILE_H
 
 #include <sys/types.h>
+#include <stdint.h>
 #include <functional>
 #include <iostream>
 #include <vector>
@@ -10,6 +11,8 @@ using namespace std;
 
 #include "page.h"
 #include "buf.h"
+#include "fsm.h"
+#include "log.h"
 
 extern DB db;
 
@@ -22,6 +25,90 @@ const unsigned MAXNAMESIZE = 50;
 enum Datatype { STRING, INTEGER, FLOAT };    // attribute data types
 enum Operator { LT, LTE, EQ, GTE, GT, NE };  // scan operators
 
+// comparison of an attribute with the value of a filter, decided at
+// compile time for each operator
+template <Operator O, class T>
+inline bool holds(const T attr, const T value)
+{
+  switch (O)
+  {
+  case LT:  return attr < value;
+  case LTE: return attr <= value;
+  case EQ:  return attr == value;
+  case GTE: return attr >= value;
+  case GT:  return attr > value;
+  case NE:  return attr != value;
+  }
+  return false;
+}
+
+// order of two attribute values of length bytes: negative, zero or
+// positive as a is below, equal to or above b by the scan operators.
+// NaN floats order after all other floats.
+const int compareAttr(const char* a, const char* b, const int length,
+                      const Datatype type);
+
+// one comparison of a scan filter: the attribute of length bytes at
+// offset in each record is compared with the value at filter
+struct ScanTerm
+{
+  int		offset;
+  int		length;
+  Datatype	type;
+  const char*	filter;
+  Operator	op;
+};
+
+// a ScanTerm compiled by startScan into a comparison function for
+// its type and operator, with the comparison value copied out
+struct ScanPred
+{
+  int		offset;
+  int		length;
+  Datatype	type;
+  Operator	op;
+  int		ival;		// value of an INTEGER term
+  float		fval;		// value of a FLOAT term
+  const char*	sval;		// value of a STRING term
+  bool		(*match)(const char* attr, const ScanPred& pred);
+};
+
+// the filter of a scan, compiled from its terms: a record matches
+// if it satisfies all of them.  A copy carries its own work space,
+// so each thread scanning with the filter needs its own copy.
+class ScanFilter
+{
+public:
+  // compile terms; no terms means no filtering
+  const Status compile(const vector<ScanTerm>& terms);
+
+  const bool matches(const Record& rec) const;
+
+  // apply the filter to n records of a page, moving the ones that
+  // match to the front; returns their number
+  const int apply(RID rids[], Record recs[], const int n);
+
+private:
+  vector<ScanPred> preds;  // all of which must match
+
+  // work space of apply
+  vector<uint64_t> matchBits;  // records still matching
+  vector<int> colInts;         // attribute values of the records
+  vector<float> colFloats;
+};
+
+// most indexes a heap file can have
+const int MAXINDEXES = 8;
+
+// an index of a heap file, on the attribute of length bytes at
+// offset; see btree.h
+struct IndexDesc
+{
+  int		offset;
+  int		length;
+  Datatype	type;
+};
+
 struct FileHdrPage
 {
   char		fileName[MAXNAMESIZE];   // name of file
@@ -29,8 +116,13 @@ struct FileHdrPage
   int		lastPage;	// pageNo of last data page in file
   int		pageCnt;	// number of pages
   int		recCnt;		// record count
+  FSMDir	fsm;		// directory of the free-space map
+  int		indexCnt;	// number of indexes
+  IndexDesc	indexes[MAXINDEXES];
 };
 
+class BTreeIndex;
+
 
 // class definition of heapFile
 class HeapFile {
@@ -44,11 +136,27 @@ protected:
    int   	curPageNo;	// page number of pinned page
    bool  	curDirtyFlag;   // true if page has been updated
    RID   	curRec;         // rid of last record returned
+   FreeSpaceMap freeMap;        // free space of the data pages
+   vector<BTreeIndex*> indexes; // opened by indexRecord, as listed
+
+   // add (or remove) the entries of record rec at rid to (from) the
+   // indexes of the file
+   const Status indexRecord(const Record & rec, const RID & rid,
+                            const bool add);
+   void closeIndexes();
+
+   // append a log record of a change to the file, see log.h; lsn is
+   // its LSN, 0 when logging is off
+   const Status logChange(const LogType type, const int pageNo,
+                          const int slotNo, const int prevPageNo,
+                          const void* data, const int length, LSN& lsn);
 
 public:
 
-  // initialize
-  HeapFile(const string & name, Status& returnStatus);
+  // initialize.  mapped opens the file read-only and mapped, see
+  // File; changes then return FILEREADONLY.
+  HeapFile(const string & name, Status& returnStatus,
+           const bool mapped = false);
 
   // destructor
   ~HeapFile();
@@ -58,6 +166,16 @@ public:
 
   // given a RID, read record from file, returning pointer and length
   const Status getRecord(const RID &rid, Record & rec);
+
+  // list an index in the header page, or take it off; for
+  // createIndex and destroyIndex
+  const Status addIndex(const IndexDesc & desc);
+  const Status removeIndex(const int offset);
+
+  // set the record and page counts and the last page in the header
+  // from the chain of data pages, and build a new free-space map;
+  // for recovery
+  const Status recount();
 };
 
 
@@ -65,7 +183,10 @@ class HeapFileScan : public HeapFile
 {
 public:
 
-    HeapFileScan(const string & name, Status & status);
+    // mapped scans the pages in place in a mapping of the file, for
+    // read-only scans of files larger than the pool; see File
+    HeapFileScan(const string & name, Status & status,
+                 const bool mapped = false);
 
     // end filtered scan
     ~HeapFileScan();
@@ -76,6 +197,10 @@ public:
                            const char* filter, 
                            const Operator op);
 
+    // scan for the records matching all of terms; no terms means
+    // no filtering
+    const Status startScan(const vector<ScanTerm>& terms);
+
     const Status endScan(); // terminate the scan
     const Status markScan(); // save current position of scan
     const Status resetScan(); // reset scan to last marked location
@@ -83,6 +208,12 @@ public:
     // return RID of next record that satisfies the scan 
     const Status scanNext(RID& outRid);
 
+    // return up to max of the next records that satisfy the scan,
+    // all from one page, and their number in count.  The records
+    // stay valid until the next call.  count is 0 only with FILEEOF
+    const Status scanBatch(RID rids[], Record recs[], const int max,
+                           int& count);
+
     // read current record, returning pointer and length
     const Status getRecord(Record & rec);
 
@@ -95,11 +226,7 @@ public:
     Status handlePageEnd();
 
 private:
-    int   offset;            // byte offset of filter attribute
-    int   length;            // length of filter attribute
-    Datatype type;           // datatype of filter attribute
-    const char* filter;      // comparison value of filter
-    Operator op;             // comparison operator of filter
+    ScanFilter scanFilter;
 
      // The following variables are used to preserve the state
     // of the scan when the method markScan() is invoked.
@@ -125,4 +252,70 @@ public:
     const Status insertRecord(const Record & rec, RID& outRid); 
 };
 
+
+// pages a HeapFileLoader packs in memory before writing them out
+const int LOADPAGES = 256;
+
+// Appends records to a heap file much faster than InsertFileScan.
+// Records first fill the last page of the file, then go onto pages
+// packed in memory that are written to the file in runs, bypassing
+// the buffer pool.  The header page is updated, and the first new
+// page linked after the old last page, once, by finish(); when
+// logging is on the new pages are synced first, and only that link
+// is logged.
+// No other scan of the file may be open while loading.  Indexes of
+// the file get an entry per record added, one at a time; loading
+// first and creating the indexes afterwards is much faster.
+class HeapFileLoader : public HeapFile
+{
+public:
+
+    // pages packs that many pages in memory at a time
+    HeapFileLoader(const string & name, Status & status,
+                   const int pages = LOADPAGES);
+
+    // finishes the load
+    ~HeapFileLoader();
+
+    // append one record, or n of them
+    const Status add(const Record & rec);
+    const Status add(const Record recs[], const int n);
+
+    // write out the remaining pages and update the header page
+    const Status finish();
+
+private:
+    vector<Page> batch;      // pages being packed
+    vector<int> batchNo;     // their page numbers
+    int   packed;            // pages of batch in use
+    Page* fill;              // last page of batch in use, or NULL
+    int   loadedRecs;        // records and pages added so far
+    int   loadedPages;
+    int   linkFrom;          // old last page, to link the first new one
+    int   firstNew;          // after, by finish()
+
+    const Status newPage();
+    const Status writeBatch();
+    const Status link(const int lastPageNo);
+};
+
+// Logging of the changes made by insertRecord, deleteRecord and
+// HeapFileLoader to the heap files, see log.h.  In-place updates of
+// records through markDirty, free-space maps and indexes are not
+// logged; recovery rebuilds the maps and indexes of the files it
+// touched.  Changes become durable when LogMgr::commit returns.
+//
+// startLogging first recovers the heap files named in the log
+// logName from a crash, redoing the changes logged that did not reach
+// disk, then empties it and turns logging on.  The files must be
+// closed.
+const Status startLogging(const string & logName);
+
+// write out and sync the files named in the log and empty it, to
+// keep it short.  Returns PAGEPINNED if one of the files is open.
+const Status checkpointLog();
+
+// checkpoint and turn logging off
+const Status stopLogging();
+
 #endif
@@ -0,0 +1,167 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <map>
+#include <vector>
+#include "page.h"
+#include "db.h"
+
+// bytes of log records kept in memory before they are written out
+// whether or not anyone is waiting for them
+const int LOGBUFSIZE = 64 * 1024;
+
+// bytes by which the log file is extended with zeros ahead of the
+// records, so that syncing a record does not have to sync a new
+// file size as well
+const int LOGEXTENT = 1024 * 1024;
+
+// most bytes of data a log record carries
+const int LOGMAXDATA = PAGESIZE;
+
+// kinds of log records
+enum LogType { LOGFILE, LOGDROP, LOGINSERT, LOGDELETE, LOGNEWPAGE,
+	       LOGLOAD };
+
+// header of a log record, followed by length bytes of data.  What
+// the other fields mean depends on the type:
+//   LOGFILE     the file named by the data is fileId in the records
+//               that follow, until the log is emptied
+//   LOGDROP     file fileId was destroyed, its records before this
+//               one are void
+//   LOGINSERT   the record in the data went into slot slotNo of
+//               page pageNo
+//   LOGDELETE   the record in slot slotNo of page pageNo was deleted
+//   LOGNEWPAGE  page pageNo was initialized and linked after page
+//               prevPageNo
+//   LOGLOAD     a loader wrote and synced pages pageNo to slotNo
+//               and linked them after page prevPageNo
+struct LogRec
+{
+  unsigned	sum;		// checksum of the rest of the record
+  int		length;		// of the data
+  short		type;
+  short		fileId;
+  int		pageNo;
+  int		slotNo;
+  int		prevPageNo;
+};
+
+struct LogStats
+{
+  std::atomic<long> records;	// appended, file names included
+  std::atomic<long> bytes;
+  std::atomic<long> writes;	// write system calls
+  std::atomic<long> syncs;	// fdatasync calls
+  std::atomic<long> commits;	// calls to commit
+
+  void clear()
+    {
+      records = bytes = writes = syncs = commits = 0;
+    }
+
+  LogStats() { clear(); }
+};
+
+
+// The write-ahead log.  Each change to a heap file page is described
+// by a log record appended here while the page is pinned, and the
+// page is stamped with the record's LSN; the buffer manager makes the
+// log durable up to a page's LSN before it writes the page.  Records are
+// buffered in memory and written out by whichever thread first needs
+// them on disk.  Threads that commit while another is syncing the
+// log wait for it, and then one of them syncs all of their records
+// at once, so a group of commits costs a single fdatasync.
+//
+// The log is redo only: recovery applies each record to a page whose
+// LSN is below the record's, see startLogging in heapfile.h.  LSNs
+// are byte positions in the log counted from the first record ever
+// written, so they keep growing when the log is emptied.
+class LogMgr
+{
+public:
+  // open the log in file name, creating it if it does not exist.  A
+  // record torn by a crash and whatever follows it is cut off.
+  LogMgr(const string& name, Status& status);
+
+  // syncs the records appended
+  ~LogMgr();
+
+  // append a record describing a change to file fileName, filling
+  // in its fileId, length and sum; lsn is its LSN
+  const Status append(const string& fileName, LogRec& rec,
+		      const void* data, const int length, LSN& lsn);
+
+  // append a LOGDROP record for file fileName, which is about to be
+  // destroyed; a file created under that name later gets a new id
+  const Status dropFile(const string& fileName);
+
+  // make the records up to lsn durable
+  const Status flush(const LSN lsn);
+
+  // make all records appended so far durable
+  const Status commit();
+
+  // read the record following pos into rec and data, moving pos to
+  // its LSN; FILEEOF after the last record.  For recovery, while no
+  // records are appended.
+  const Status read(LSN& pos, LogRec& rec, vector<char>& data);
+
+  // the position before the first record
+  const LSN begin() const { return base + sizeof(LogHdr); }
+
+  // LSN of the last record appended
+  const LSN lastLSN();
+
+  // the files named in the log
+  const vector<string> fileNames();
+
+  // drop all records.  The caller must have written every page they
+  // changed to disk and synced it.
+  const Status truncate();
+
+  const LogStats& getStats() const { return stats; }
+  void clearStats() { stats.clear(); }
+
+private:
+  // first bytes of the log file
+  struct LogHdr
+  {
+    unsigned	magic;
+    unsigned	unused;
+    LSN		base;		// LSN at offset 0 of the file
+  };
+
+  string	name;
+  int		fd;
+  LSN		base;
+  std::map<string, short> fileIds;	// of the files named so far
+  short		nextId;		// for the next file named
+
+  std::mutex	latch;		// protects all of these
+  std::condition_variable flushed;	// signalled when a write ends
+  vector<char>	buf;		// records not written yet
+  vector<char>	spare;		// the records being written
+  LSN		bufStart;	// LSN before the first of them
+  LSN		end;		// LSN of the last record
+  std::atomic<LSN> durable;	// synced up to
+  bool		flushing;	// a thread is writing the log
+  off_t		zeroed;		// the file is zeros from the end on, up to
+  Status	failed;		// error of a write, sticky
+
+  LogStats	stats;
+
+  void put(LogRec& rec, const void* data, const int length);
+  void named(const LogRec& rec, const vector<char>& data);
+  const Status writeOut(std::unique_lock<std::mutex>& lk, const bool sync);
+  const Status writeHeader(const int unixFile, const LSN newBase);
+  const Status extend(const off_t offset);
+  static const unsigned checksum(const LogRec& rec, const void* data);
+};
+
+// the log changes are written to; NULL when logging is off
+extern LogMgr* logMgr;
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+using namespace std;
+
+// buckets of a latency histogram: bucket b counts latencies from
+// 2^b up to 2^(b+1) nanoseconds, the last one everything longer
+const int HISTBUCKETS = 36;
+
+// the per-file counters are split into this many stripes, each
+// updated by a share of the threads, so that threads working on one
+// file do not fight over a cache line
+const int METRICSTRIPES = 16;
+
+// one in this many calls to BufMgr::readPage is timed
+const int METRICSAMPLE = 16;
+
+// nanoseconds on a monotonic clock
+inline long long metricsNow()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// A histogram of latencies.  Updates and reads are relaxed atomics,
+// so it can be read while it is being updated.
+struct LatencyHistogram
+{
+  std::atomic<unsigned long long> counts[HISTBUCKETS];
+  std::atomic<unsigned long long> totalNs;
+
+  void record(const long long ns)
+    {
+      int b = ns < 2 ? 0 : 63 - __builtin_clzll(ns);
+      if (b >= HISTBUCKETS) b = HISTBUCKETS - 1;
+      counts[b].fetch_add(1, std::memory_order_relaxed);
+      totalNs.fetch_add(ns, std::memory_order_relaxed);
+    }
+
+  // record the time since start, from metricsNow
+  void since(const long long start) { record(metricsNow() - start); }
+
+  unsigned long long count() const;
+
+  // upper bound in ns of the fraction p of the latencies, 0 if none
+  long long percentile(const double p) const;
+
+  void clear();
+  LatencyHistogram() { clear(); }
+};
+
+// what happened to the pages of one file in the buffer pool and on
+// disk
+// BufMgr::readPage calls that succeed are the sum of the first three
+enum FileCounter {
+  FCHITS,		// pages found in the pool
+  FCMISSES,		// pages read into the pool
+  FCMAPPED,		// pages served from the file's mapping
+  FCREADS,		// pages read from disk, read-ahead included
+  FCWRITES,		// pages written to disk
+  FCEVICTIONS,		// pages replaced in the pool
+  FCDIRTYEVICTIONS,	// of them written back first
+  FCPINWAITS,		// waits for a page another thread was reading
+  FCCOUNTERS
+};
+
+class FileMetrics
+{
+public:
+  void add(const FileCounter c, const long long n = 1)
+    {
+      stripes[stripe()].c[c].fetch_add(n, std::memory_order_relaxed);
+    }
+
+  // the sum over the stripes
+  long long get(const FileCounter c) const;
+
+  void clear();
+  FileMetrics() { clear(); }
+
+private:
+  struct alignas(64) Stripe
+  {
+    std::atomic<long long> c[FCCOUNTERS];
+  };
+  Stripe stripes[METRICSTRIPES];
+
+  static int stripe();		// of the calling thread
+};
+
+// The metrics of the system.  Files are registered by name when they
+// are first opened and keep their counters while closed, until
+// clear(), and lose them when the file is destroyed, so that the
+// temporary files of sorts and joins do not pile up.  The counters
+// are otherwise never freed, since files may still be closed while
+// the program exits.  Latencies are kept for calls to
+// BufMgr::readPage (sampled) and for each page read or write the I/O
+// layer issues, from the request to its completion.  snapshot() may
+// be called at any time from any thread; it does not stop the others.
+class MetricsRegistry
+{
+public:
+  MetricsRegistry() : enabled(true) {}
+
+  // the counters of file name, valid until the file is destroyed
+  FileMetrics* file(const string& name);
+
+  // forget the counters of file name, which is no longer open
+  void drop(const string& name);
+
+  // the metrics as text, or as one JSON object
+  const string snapshot(const bool json);
+
+  // zero every counter and histogram
+  void clear();
+
+  // when disabled, neither file counters nor histograms are updated
+  std::atomic<bool> enabled;
+
+  LatencyHistogram readPageTime; // BufMgr::readPage
+  LatencyHistogram readTime;	// page read requests
+  LatencyHistogram writeTime;	// page write requests
+
+private:
+  std::mutex latch;		// protects files
+  std::map<string, FileMetrics*> files;
+};
+
+extern MetricsRegistry metrics;
+
+#endif
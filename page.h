@@ -17,14 +17,38 @@ struct Record
   int length;
 };
 
+// page size in bytes, set at build time: make PAGESIZE=8192.  A
+// power of two from 1024 to 65536.  Files record the size they were
+// created with and do not open under another.
+#ifndef MINIREL_PAGESIZE
+#define MINIREL_PAGESIZE 1024
+#endif
+
+// offsets and lengths within a page.  A short covers pages up to
+// 32 KB; larger pages need an int.
+#if MINIREL_PAGESIZE > 32768
+typedef int pageoff_t;
+#else
+typedef short pageoff_t;
+#endif
+
 // slot structure
 struct slot_t {
-        short	offset;  
-        short	length;  // equals -1 if slot is not in use
+        pageoff_t	offset;  
+        pageoff_t	length;  // equals -1 if slot is not in use
 };
 
-const unsigned PAGESIZE = 1024;
-const unsigned DPFIXED= sizeof(slot_t)+4*sizeof(short)+2*sizeof(int);
+// log sequence number: the position in the write-ahead log just past
+// the record of a change, see log.h
+typedef unsigned long long LSN;
+
+const unsigned PAGESIZE = MINIREL_PAGESIZE;
+static_assert(PAGESIZE >= 1024 && PAGESIZE <= 65536 &&
+              (PAGESIZE & (PAGESIZE - 1)) == 0,
+              "MINIREL_PAGESIZE must be a power of two from 1024 to 65536");
+
+const unsigned DPFIXED= sizeof(slot_t)+4*sizeof(pageoff_t)+2*sizeof(int)+
+                        sizeof(LSN);
 const unsigned PAGEDATASIZE = PAGESIZE-DPFIXED+sizeof(slot_t);
 // size of the data area of a page
 
@@ -33,18 +57,30 @@ const unsigned PAGEDATASIZE = PAGESIZE-DPFIXED+sizeof(slot_t);
 // deletions are performed. Notice, however, that the slot
 // array cannot be compacted.  Notice, this class does not keep
 // the records align, relying instead on upper levels to take
-// care of non-aligned attributes
+// care of non-aligned attributes.  The slot array ends where the
+// fixed fields begin: slot i, for i from 0 down to slotCnt+1, is the
+// (1-i)'th slot_t from the end of data.
+//
+// The last sizeof(LSN) bytes of every page, whatever it holds, are
+// the LSN of the last logged change to it, 0 if none.  The buffer
+// manager forces the log up to it before writing the page.
 
 class Page {
 private:
-    char 	data[PAGESIZE - DPFIXED]; 
-    slot_t 	slot[1]; // first element of slot array - grows backwards!
-    short	slotCnt; // number of slots in use;
-    short	freePtr; // offset of first free byte in data[]
-    short	freeSpace; // number of bytes free in data[]
-    short	dummy;	// for alignment purposes
+    char 	data[PAGESIZE - DPFIXED + sizeof(slot_t)]; // slot array at the end
+    pageoff_t	slotCnt; // number of slots in use;
+    pageoff_t	freePtr; // offset of first free byte in data[]
+    pageoff_t	freeSpace; // number of bytes free in data[]
+    pageoff_t	dummy;	// for alignment purposes
     int		nextPage; // forwards pointer
     int		curPage;  // page number of current pointer
+    LSN		lsn;	  // of the last logged change
+
+    // slot i of the slot array, which grows backwards
+    slot_t& slot(const int i)
+      { return reinterpret_cast<slot_t*>(data + sizeof(data))[i - 1]; }
+    const slot_t& slot(const int i) const
+      { return reinterpret_cast<const slot_t*>(data + sizeof(data))[i - 1]; }
 
 public:
     void init(const int pageNo); // initialize a new page
@@ -52,11 +88,19 @@ public:
 
     const Status getNextPage(int& pageNo) const; // returns value of nextPage
     const Status setNextPage(const int pageNo); // sets value of nextPage to pageNo
-    const short getFreeSpace() const; // returns amount of free space
+    const Status getPageNo(int& pageNo) const; // page number given to init
+    const int getFreeSpace() const; // returns amount of free space
+    const LSN getLSN() const { return lsn; }
+    void setLSN(const LSN newLSN) { lsn = newLSN; }
 
     // inserts a new record (rec) into the page, returns RID of record 
     const Status insertRecord(const Record & rec, RID& rid);
 
+    // adds a record in a new slot without looking for an empty one,
+    // for pages being built that never had a record deleted.
+    // returns NOSPACE if the record does not fit
+    const Status appendRecord(const Record & rec, RID& rid);
+
     // delete the record with the specified rid
     const Status deleteRecord(const RID & rid);
 
@@ -70,6 +114,15 @@ public:
 
     // returns reference to record with RID rid
     const Status getRecord(const RID & rid, Record & rec);
+
+    // returns the RIDs and references of up to max records, in slot
+    // order from slot slotNo on, and their number in n.  slotNo is
+    // advanced past the slots looked at.  returns ENDOFPAGE if the
+    // last slot was reached, OK if max records were returned first
+    const Status getRecords(int& slotNo, RID rids[], Record recs[],
+                            const int max, int& n);
 };
 
+static_assert(sizeof(Page) == PAGESIZE, "Page is not PAGESIZE bytes");
+
 #endif
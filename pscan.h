@@ -0,0 +1,118 @@
+#ifndef PSCAN_H
+#define PSCAN_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "heapfile.h"
+
+// pages a worker of a parallel scan claims from its range at a time
+const int SCANMORSEL = 16;
+
+// bytes of matching records a worker collects before passing them
+// to the merge queue, and chunks of them the queue holds per worker
+const int SCANCHUNK = 16 * PAGESIZE;
+const int SCANQUEUE = 4;
+
+// A scan of a heap file by a pool of worker threads.  Instead of
+// following the nextPage chain, the pages of the file are split into
+// one range per worker; a worker takes SCANMORSEL pages at a time
+// from the front of its range and, once it is used up, steals the
+// back half of the largest range left.  Every page of the file other
+// than the header and the free-space map is a data page of the heap
+// file, so no page is missed; pages that do not carry their own page
+// number (pages on the free list of the file) are passed over.
+//
+// The matching records of each page go either to a sink called by
+// the worker (run), for instance to aggregate into a per-worker
+// total, or to a merge queue read by the thread that started the
+// scan (startScan and scanNext).  Records come in no particular
+// order.  No other scan of the file may change it meanwhile.
+class ParallelScan : public HeapFile
+{
+public:
+  // called by worker worker, 0 to threads-1, with n matching records
+  // of one page, pinned until the call returns
+  typedef std::function<void(const int worker, const RID rids[],
+			     const Record recs[], const int n)> Sink;
+
+  ParallelScan(const string& name, const int threads, Status& status);
+
+  // ends the scan and stops the workers
+  ~ParallelScan();
+
+  const int threadCount() const { return (int) workers.size(); }
+
+  // scan the file for the records matching all of terms, handing
+  // them to sink; returns when all workers are done
+  const Status run(const vector<ScanTerm>& terms, const Sink& sink);
+
+  // start a scan whose matches are read back with scanNext
+  const Status startScan(const vector<ScanTerm>& terms);
+
+  // the next matching record, a copy that stays valid until the next
+  // call; FILEEOF when all have been returned
+  const Status scanNext(RID& outRid, Record& rec);
+
+  // stop the scan started by startScan, dropping what is left
+  const Status endScan();
+
+  // pages taken from another worker's range during the last scan
+  const int steals() const { return stolen; }
+
+private:
+  // range of page numbers not yet claimed by a worker
+  struct Range
+  {
+    std::mutex	latch;		// protects next and end
+    int		next;
+    int		end;
+  };
+
+  // matching records copied for the merge queue; data has room for
+  // SCANCHUNK bytes and a page more, so recs never move
+  struct Chunk
+  {
+    vector<RID>	rids;
+    vector<Record> recs;
+    vector<char> data;
+  };
+
+  std::vector<std::thread> workers;
+  Range*	ranges;			// one per worker
+  vector<bool>	skip;			// header and map pages
+  ScanFilter	filter;			// compiled filter of the scan
+  const Sink*	sink;			// NULL when queueing
+  int		generation;		// bumped when a scan starts
+  int		running;		// workers still scanning
+  bool		stop;
+  Status	scanStatus;		// first error of a worker
+  std::atomic<bool> cancelled;		// workers should give up
+  std::atomic<int> stolen;
+  std::mutex	latch;			// protects all of the above
+  std::condition_variable work;		// signalled when a scan starts
+  std::condition_variable done;		// signalled when a worker is done
+					// or the queue grows
+
+  // merge queue
+  std::deque<Chunk*> queue;		// chunks ready for scanNext
+  vector<Chunk*> spare;			// chunks to reuse
+  vector<Chunk*> filling;		// chunk of each worker, or NULL
+  std::condition_variable drained;	// signalled when the queue shrinks
+  Chunk*	current;		// chunk scanNext is reading
+  int		currentPos;
+
+  const Status launch(const vector<ScanTerm>& terms, const Sink* s);
+  void wait(std::unique_lock<std::mutex>& lk);
+  bool claim(const int w, int& first, int& last);
+  void worker(const int w);
+  const Status scanPages(const int w, ScanFilter& f, const int first,
+			 const int last);
+  void enqueue(const int w, const RID rids[], const Record recs[],
+	       const int n);
+  void pass(Chunk* c);
+};
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef SORT_H
+#define SORT_H
+
+#include "heapfile.h"
+
+// records a run being merged reads at a time
+const int SORTBATCH = 256;
+
+// The records of a heap file in order of the attribute of length
+// bytes at offset, compared like a scan filter of its Datatype, by an
+// external merge sort that stays within a budget of frames pages of
+// memory.  Equal keys keep the order of the file, and records too
+// short to hold the attribute come first.
+//
+// Records are read by a HeapFileScan and copied into a sort area of
+// the pages the budget leaves after the input scan and the output
+// batch; each time it fills, it is sorted and written out as a run,
+// a temporary heap file loaded by a HeapFileLoader.  Runs are then
+// merged, as many at a time as the budget has room for the two pages
+// each of their scans pins, until one merge is left; that one is
+// done by next(), a record at a time.  When all of the file fits in
+// the sort area, nothing is written and next() reads it from memory.
+// Temporary files are named after the input file and removed as soon
+// as they have been merged.
+class SortedFile
+{
+public:
+  SortedFile(const string& fileName, const int offset, const int length,
+	     const Datatype type, const int frames, Status& status);
+
+  // removes the runs left
+  ~SortedFile();
+
+  // the next record in order, which stays valid until the next call;
+  // FILEEOF after the last one
+  const Status next(Record& rec);
+
+  // runs the input was split into, and passes made over the records,
+  // counting the one forming the runs
+  const int runCount() const { return runs; }
+  const int passCount() const { return passes; }
+
+private:
+  // a run being merged, read a page at a time
+  struct Source
+  {
+    string	name;
+    HeapFileScan* scan;
+    RID		rids[SORTBATCH];
+    Record	recs[SORTBATCH];
+    int		count;
+    int		pos;			// current record of recs
+    bool	done;
+  };
+
+  // a record in the sort area
+  struct Item
+  {
+    int		start;
+    int		length;
+  };
+
+  string	inName;
+  int		offset;
+  int		length;
+  Datatype	type;
+  int		outPages;		// batch of a run being written
+  int		fanIn;			// runs merged at a time
+  int		runs;
+  int		passes;
+
+  vector<char>	area;			// sort area
+  vector<Item>	items;
+  int		used;			// bytes of area and items in use
+  int		nextItem;		// of items, read by next()
+
+  vector<string> files;			// runs not yet merged
+  vector<Source*> sources;		// of the final merge
+  vector<int>	tree;			// losers of the merge, tree[0] wins
+  bool		started;		// the final merge has its first winner
+
+  const int compare(const Record& a, const Record& b) const;
+  const bool beats(const int a, const int b) const;
+  void replay(int s);
+  const Status formRuns(const int areaPages);
+  const Status writeRun(const string& name);
+  const Status openSources(const vector<string>& names);
+  const Status advance(Source* s);
+  void closeSources();
+  const Status merge(const vector<string>& names, const string& outName);
+  const string tempName();
+};
+
+// write the records of heap file inName to the new heap file outName,
+// sorted as a SortedFile of that budget sorts them
+const Status sortHeapFile(const string& inName, const string& outName,
+			  const int offset, const int length,
+			  const Datatype type, const int frames);
+
+#endif